@@ -12,6 +12,8 @@
 #define MIN_TEXT_LENGTH 5
 #define MAX_SCHEMA_FIELDS 16
 #define BUFFER_SIZE 65536
+#define RECORD_BATCH_SIZE 256
+#define ARENA_SIZE (BUFFER_SIZE * 16)
 
 typedef enum {
     TYPE_UNDEFINED,
@@ -72,6 +74,34 @@ typedef struct {
     int unique_classes;
 } ProcessingStats;
 
+// Bump allocator backing one record batch; reset wholesale between batches
+typedef struct {
+    char *base;
+    size_t used;
+    size_t capacity;
+} Arena;
+
+// Field view into the arena with its length known up front (still NUL-terminated)
+typedef struct {
+    char *data;
+    size_t len;
+} FieldSlice;
+
+typedef struct {
+    FieldSlice fields[MAX_FIELDS];
+    int field_count;
+    int line_number; // value of total_lines when the row was read
+    bool keep;
+} Record;
+
+// A batch of parsed rows whose field bytes live contiguously in the arena
+typedef struct {
+    Record *records;
+    int count;
+    int capacity;
+    Arena arena;
+} RecordBatch;
+
 // Enhanced string utilities
 static void safe_strcpy(char *dest, const char *src, size_t dest_size) {
     if (!dest || !src || dest_size == 0) return;
@@ -91,57 +121,118 @@ static int strcasecmp_portable(const char *s1, const char *s2) {
     return tolower((unsigned char)*s1) - tolower((unsigned char)*s2);
 }
 
-// Enhanced text cleaning with more HTML entities and better Unicode handling
-static void clean_text(char *text, size_t max_len, bool strict) {
-    if (!text) return;
-    size_t len = strlen(text);
+// Arena and record batch management
+static bool arena_init(Arena *arena, size_t capacity) {
+    arena->base = malloc(capacity);
+    arena->used = 0;
+    arena->capacity = arena->base ? capacity : 0;
+    return arena->base != NULL;
+}
+
+static char *arena_alloc(Arena *arena, size_t size) {
+    if (size > arena->capacity - arena->used) return NULL;
+    char *ptr = arena->base + arena->used;
+    arena->used += size;
+    return ptr;
+}
+
+static void arena_free(Arena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->used = arena->capacity = 0;
+}
+
+static bool batch_init(RecordBatch *batch, int capacity, size_t arena_size) {
+    batch->records = calloc(capacity, sizeof(Record));
+    batch->count = 0;
+    batch->capacity = capacity;
+    if (!batch->records) return false;
+    if (!arena_init(&batch->arena, arena_size)) {
+        free(batch->records);
+        batch->records = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void batch_reset(RecordBatch *batch) {
+    batch->count = 0;
+    batch->arena.used = 0;
+}
+
+static void batch_free(RecordBatch *batch) {
+    free(batch->records);
+    batch->records = NULL;
+    batch->count = batch->capacity = 0;
+    arena_free(&batch->arena);
+}
+
+// Enhanced text cleaning with more HTML entities and better Unicode handling.
+// Works in place on a field of known length and returns the cleaned length.
+static size_t clean_text(char *text, size_t len, size_t max_len, bool strict) {
+    if (!text) return 0;
     if (len == 0 || strcasecmp_portable(text, "nan") == 0 || 
         strcasecmp_portable(text, "null") == 0 || strcasecmp_portable(text, "n/a") == 0) {
         text[0] = '\0';
-        return;
+        return 0;
     }
 
     // Trim leading/trailing whitespace
     char *start = text;
-    while (*start && isspace((unsigned char)*start)) start++;
-    char *end = text + len - 1;
-    while (end > start && isspace((unsigned char)*end)) end--;
-    *(end + 1) = '\0';
-    if (start != text) memmove(text, start, strlen(start) + 1);
+    char *end = text + len;
+    while (start < end && isspace((unsigned char)*start)) start++;
+    while (end > start && isspace((unsigned char)*(end - 1))) end--;
+    len = (size_t)(end - start);
+    if (start != text) memmove(text, start, len);
+    text[len] = '\0';
 
     // Enhanced HTML entity decoding
-    struct { const char *entity; const char *replacement; } entities[] = {
-        {"&lt;", "<"}, {"&gt;", ">"}, {"&amp;", "&"}, {"&quot;", "\""}, 
-        {"&apos;", "'"}, {"&nbsp;", " "}, {"&#39;", "'"}, {"&#34;", "\""},
-        {"&hellip;", "..."}, {"&mdash;", "--"}, {"&ndash;", "-"},
-        {"&lsquo;", "'"}, {"&rsquo;", "'"}, {"&ldquo;", "\""}, {"&rdquo;", "\""}
+#define ENTITY(e, r) {e, sizeof(e) - 1, r, sizeof(r) - 1}
+    static const struct {
+        const char *entity; size_t entity_len;
+        const char *replacement; size_t repl_len;
+    } entities[] = {
+        ENTITY("&lt;", "<"), ENTITY("&gt;", ">"), ENTITY("&amp;", "&"), ENTITY("&quot;", "\""), 
+        ENTITY("&apos;", "'"), ENTITY("&nbsp;", " "), ENTITY("&#39;", "'"), ENTITY("&#34;", "\""),
+        ENTITY("&hellip;", "..."), ENTITY("&mdash;", "--"), ENTITY("&ndash;", "-"),
+        ENTITY("&lsquo;", "'"), ENTITY("&rsquo;", "'"), ENTITY("&ldquo;", "\""), ENTITY("&rdquo;", "\"")
     };
-
-    for (int i = 0; i < sizeof(entities) / sizeof(entities[0]); i++) {
-        char *pos;
-        while ((pos = strstr(text, entities[i].entity)) != NULL) {
-            size_t entity_len = strlen(entities[i].entity);
-            size_t repl_len = strlen(entities[i].replacement);
-            memmove(pos + repl_len, pos + entity_len, strlen(pos + entity_len) + 1);
-            memcpy(pos, entities[i].replacement, repl_len);
+#undef ENTITY
+
+    if (memchr(text, '&', len)) {
+        for (size_t i = 0; i < sizeof(entities) / sizeof(entities[0]); i++) {
+            // Replacements never contain entity characters, so resuming at pos is safe
+            char *pos = text;
+            while ((pos = strstr(pos, entities[i].entity)) != NULL) {
+                size_t tail = len - (size_t)(pos - text) - entities[i].entity_len;
+                memmove(pos + entities[i].repl_len, pos + entities[i].entity_len, tail + 1);
+                memcpy(pos, entities[i].replacement, entities[i].repl_len);
+                len -= entities[i].entity_len - entities[i].repl_len;
+            }
         }
     }
 
-    // Strip HTML/XML tags with better handling
-    char *tag_start;
-    while ((tag_start = strchr(text, '<')) != NULL) {
-        char *tag_end = strchr(tag_start, '>');
-        if (!tag_end) {
-            *tag_start = '\0';
-            break;
+    // Strip HTML/XML tags in a single pass; an unterminated tag truncates the text
+    char *tag_start = memchr(text, '<', len);
+    if (tag_start) {
+        char *rd = tag_start, *wr = tag_start, *stop = text + len;
+        while (rd < stop) {
+            if (*rd == '<') {
+                char *tag_end = memchr(rd, '>', (size_t)(stop - rd));
+                if (!tag_end) break;
+                rd = tag_end + 1;
+            } else {
+                *wr++ = *rd++;
+            }
         }
-        memmove(tag_start, tag_end + 1, strlen(tag_end + 1) + 1);
+        len = (size_t)(wr - text);
+        text[len] = '\0';
     }
 
     // Remove control characters and normalize whitespace
-    char *rd = text, *wr = text;
+    char *rd = text, *wr = text, *stop = text + len;
     bool last_space = false;
-    while (*rd) {
+    while (rd < stop) {
         unsigned char c = (unsigned char)*rd;
         if (c < 32 && c != '\t' && c != '\n' && c != '\r') {
             // Skip control characters
@@ -156,13 +247,14 @@ static void clean_text(char *text, size_t max_len, bool strict) {
         }
         rd++;
     }
+    len = (size_t)(wr - text);
     *wr = '\0';
 
     // Remove excessive punctuation in strict mode
     if (strict) {
         char *src = text, *dst = text;
         int punct_count = 0;
-        while (*src) {
+        while (src < text + len) {
             if (ispunct((unsigned char)*src)) {
                 if (++punct_count <= 3) *dst++ = *src;
             } else {
@@ -171,61 +263,75 @@ static void clean_text(char *text, size_t max_len, bool strict) {
             }
             src++;
         }
+        len = (size_t)(dst - text);
         *dst = '\0';
     }
 
     // Final length checks
-    len = strlen(text);
     if (len < MIN_TEXT_LENGTH) {
         text[0] = '\0';
-        return;
+        return 0;
     }
     if (len >= max_len) {
-        text[max_len - 1] = '\0';
+        len = max_len - 1;
+        text[len] = '\0';
     }
+    return len;
 }
 
-// Advanced CSV parser with configurable delimiter and quote handling
-static int parse_csv_line(char *line, char fields[][MAX_LINE_LENGTH], int max_fields, char delimiter) {
+// Advanced CSV parser with configurable delimiter and quote handling.
+// Unquoted field bytes are written back to back into the arena; each field
+// is at most as long as its source, so len + max_fields bytes always suffice.
+static int parse_csv_line(const char *line, size_t len, FieldSlice *fields, int max_fields,
+                          char delimiter, Arena *arena) {
+    char *dst = arena_alloc(arena, len + (size_t)max_fields);
+    if (!dst) return 0;
+
     int field_count = 0;
     bool in_quotes = false;
-    char *ptr = line;
-    char buffer[MAX_LINE_LENGTH];
-    int buf_pos = 0;
+    const char *ptr = line;
+    const char *stop = line + len;
+    char *field_start = dst;
     char quote_char = '"';
 
     // Auto-detect quote character if not standard
-    if (strchr(line, '\'') && !strchr(line, '"')) {
+    if (memchr(line, '\'', len) && !memchr(line, '"', len)) {
         quote_char = '\'';
     }
 
-    while (*ptr && field_count < max_fields) {
+    while (ptr < stop && field_count < max_fields) {
         if (*ptr == quote_char) {
-            if (in_quotes && *(ptr + 1) == quote_char) {
+            if (in_quotes && ptr + 1 < stop && *(ptr + 1) == quote_char) {
                 // Escaped quote
-                if (buf_pos < MAX_LINE_LENGTH - 1) buffer[buf_pos++] = quote_char;
+                if (dst - field_start < MAX_LINE_LENGTH - 1) *dst++ = quote_char;
                 ptr += 2;
                 continue;
             }
             in_quotes = !in_quotes;
             ptr++;
         } else if (*ptr == delimiter && !in_quotes) {
-            buffer[buf_pos] = '\0';
-            safe_strcpy(fields[field_count++], buffer, MAX_LINE_LENGTH);
-            buf_pos = 0;
+            fields[field_count].data = field_start;
+            fields[field_count].len = (size_t)(dst - field_start);
+            field_count++;
+            *dst++ = '\0';
+            field_start = dst;
             ptr++;
         } else {
-            if (buf_pos < MAX_LINE_LENGTH - 1) buffer[buf_pos++] = *ptr;
+            if (dst - field_start < MAX_LINE_LENGTH - 1) *dst++ = *ptr;
             ptr++;
         }
     }
 
     // Handle last field
     if (field_count < max_fields) {
-        buffer[buf_pos] = '\0';
-        safe_strcpy(fields[field_count++], buffer, MAX_LINE_LENGTH);
+        fields[field_count].data = field_start;
+        fields[field_count].len = (size_t)(dst - field_start);
+        field_count++;
+        *dst++ = '\0';
     }
 
+    // Hand the unused tail of the reservation back to the arena
+    arena->used = (size_t)(dst - arena->base);
     return field_count;
 }
 
@@ -280,12 +386,12 @@ static EncodingType detect_encoding(FILE *file) {
 }
 
 // Data validation functions
-static bool validate_field(const char *field, const FieldSchema *schema) {
+static bool validate_field(const FieldSlice *field, const FieldSchema *schema) {
     if (!field || !schema) return false;
 
-    int len = strlen(field);
+    size_t len = field->len;
     if (schema->required && len == 0) return false;
-    if (len < schema->min_length || (schema->max_length > 0 && len > schema->max_length)) {
+    if (len < (size_t)schema->min_length || (schema->max_length > 0 && len > (size_t)schema->max_length)) {
         return false;
     }
 
@@ -293,17 +399,17 @@ static bool validate_field(const char *field, const FieldSchema *schema) {
 }
 
 // Duplicate detection using simple hash
-static unsigned int hash_string(const char *str) {
+static unsigned int hash_string(const char *str, size_t len) {
     unsigned int hash = 5381;
-    while (*str) {
-        hash = ((hash << 5) + hash) + (unsigned char)*str++;
+    for (size_t i = 0; i < len; i++) {
+        hash = ((hash << 5) + hash) + (unsigned char)str[i];
     }
     return hash;
 }
 
 
-static bool is_duplicate(const char *text, unsigned int *seen_hashes, int *hash_count, int max_hashes) {
-    unsigned int hash = hash_string(text);
+static bool is_duplicate(const char *text, size_t len, unsigned int *seen_hashes, int *hash_count, int max_hashes) {
+    unsigned int hash = hash_string(text, len);
     for (int i = 0; i < *hash_count; i++) {
         if (seen_hashes[i] == hash) return true;
     }
@@ -314,39 +420,149 @@ static bool is_duplicate(const char *text, unsigned int *seen_hashes, int *hash_
 }
 
 // Enhanced output formatting
-static void write_output_json(FILE *out, const char *fields[], const FieldSchema *schema, int field_count) {
+static void write_output_json(FILE *out, const FieldSlice *fields, const FieldSchema *schema, int field_count) {
     fprintf(out, "{");
     for (int i = 0; i < field_count; i++) {
         if (i > 0) fprintf(out, ",");
-        fprintf(out, "\"%s\":\"%s\"", schema[i].name, fields[i]);
+        fprintf(out, "\"%s\":\"%.*s\"", schema[i].name, (int)fields[i].len, fields[i].data);
     }
     fprintf(out, "}\n");
 }
 
-static void write_output_txt(FILE *out, const char *fields[], const FieldSchema *schema, 
+static void write_output_txt(FILE *out, const FieldSlice *fields, const FieldSchema *schema, 
                            int field_count, DatasetType type) {
     switch (type) {
         case TYPE_SENTIMENT:
-            fprintf(out, "Text: %s\nSentiment: %s\n---\n", fields[0], fields[1]);
+            fprintf(out, "Text: %.*s\nSentiment: %.*s\n---\n",
+                   (int)fields[0].len, fields[0].data, (int)fields[1].len, fields[1].data);
             break;
         case TYPE_LEETCODE:
-            fprintf(out, "Problem: %s\nDifficulty: %s\nDescription: %s\n---\n", 
-                   fields[0], fields[1], fields[2]);
+            fprintf(out, "Problem: %.*s\nDifficulty: %.*s\nDescription: %.*s\n---\n", 
+                   (int)fields[0].len, fields[0].data, (int)fields[1].len, fields[1].data,
+                   (int)fields[2].len, fields[2].data);
             break;
         case TYPE_QA:
-            fprintf(out, "Question: %s\nAnswer: %s\n---\n", fields[0], fields[1]);
+            fprintf(out, "Question: %.*s\nAnswer: %.*s\n---\n",
+                   (int)fields[0].len, fields[0].data, (int)fields[1].len, fields[1].data);
             break;
         case TYPE_CLASSIFICATION:
-            fprintf(out, "Text: %s\nCategory: %s\n---\n", fields[0], fields[1]);
+            fprintf(out, "Text: %.*s\nCategory: %.*s\n---\n",
+                   (int)fields[0].len, fields[0].data, (int)fields[1].len, fields[1].data);
             break;
         default:
             for (int i = 0; i < field_count; i++) {
-                fprintf(out, "%s: %s\n", schema[i].name, fields[i]);
+                fprintf(out, "%s: %.*s\n", schema[i].name, (int)fields[i].len, fields[i].data);
             }
             fprintf(out, "---\n");
     }
 }
 
+// Batch stages: each pass walks a whole batch of parsed rows with known field lengths
+
+// Read up to limit non-empty rows into the batch. Returns the number of rows read;
+// zero means end of input.
+static int fill_batch(FILE *csv, RecordBatch *batch, int limit, char delimiter,
+                      ProcessingStats *stats) {
+    char line[MAX_LINE_LENGTH];
+    batch_reset(batch);
+
+    while (batch->count < limit && batch->count < batch->capacity &&
+           batch->arena.capacity - batch->arena.used >= MAX_LINE_LENGTH + MAX_FIELDS &&
+           fgets(line, sizeof(line), csv)) {
+        stats->total_lines++;
+
+        // Remove newline
+        size_t len = strcspn(line, "\r\n");
+        if (len == 0) continue;
+
+        Record *rec = &batch->records[batch->count++];
+        rec->field_count = parse_csv_line(line, len, rec->fields, MAX_FIELDS, delimiter, &batch->arena);
+        rec->line_number = stats->total_lines;
+        rec->keep = true;
+    }
+
+    return batch->count;
+}
+
+static void clean_batch(RecordBatch *batch, const ProcessingConfig *config, ProcessingStats *stats) {
+    static char empty_field[1] = "";
+
+    for (int r = 0; r < batch->count; r++) {
+        Record *rec = &batch->records[r];
+
+        // Validate minimum field count
+        bool valid = true;
+        if (rec->field_count < config->field_count) {
+            // Missing schema fields are written out as empty strings
+            for (int i = rec->field_count; i < config->field_count; i++) {
+                rec->fields[i].data = empty_field;
+                rec->fields[i].len = 0;
+            }
+            stats->error_lines++;
+            if (config->strict_mode) {
+                rec->keep = false;
+                continue;
+            }
+            valid = false;
+        }
+
+        // Clean and validate fields
+        for (int i = 0; i < rec->field_count && i < config->field_count; i++) {
+            FieldSlice *field = &rec->fields[i];
+            field->len = clean_text(field->data, field->len, MAX_LINE_LENGTH, config->strict_mode);
+
+            if (config->validate_data && !validate_field(field, &config->fields[i])) {
+                valid = false;
+                break;
+            }
+        }
+
+        if (!valid) {
+            stats->error_lines++;
+            if (config->strict_mode) rec->keep = false;
+        }
+    }
+}
+
+static void dedup_batch(RecordBatch *batch, unsigned int *seen_hashes, int *hash_count,
+                        int max_hashes, ProcessingStats *stats) {
+    for (int r = 0; r < batch->count; r++) {
+        Record *rec = &batch->records[r];
+        if (!rec->keep || rec->field_count == 0) continue;
+
+        if (is_duplicate(rec->fields[0].data, rec->fields[0].len, seen_hashes, hash_count, max_hashes)) {
+            stats->duplicate_lines++;
+            rec->keep = false;
+        }
+    }
+}
+
+static void write_batch(FILE *out, const RecordBatch *batch, const ProcessingConfig *config,
+                        ProcessingStats *stats) {
+    bool json = strcmp(config->output_format, "json") == 0;
+
+    for (int r = 0; r < batch->count; r++) {
+        const Record *rec = &batch->records[r];
+        if (!rec->keep) continue;
+
+        // Write output in specified format
+        if (json) {
+            write_output_json(out, rec->fields, config->fields, rec->field_count);
+        } else {
+            write_output_txt(out, rec->fields, config->fields, rec->field_count, config->type);
+        }
+
+        stats->processed_lines++;
+        stats->avg_text_length += rec->fields[0].len;
+
+        if (stats->processed_lines % 1000 == 0) {
+            printf("Processed %d/%d lines (%.1f%%)...\n", 
+                   stats->processed_lines, rec->line_number,
+                   100.0 * stats->processed_lines / rec->line_number);
+        }
+    }
+}
+
 // Main processing function with enhanced capabilities
 static void process_file_enhanced(const char *input_file, const char *output_file, 
                                 ProcessingConfig *config, ProcessingStats *stats) {
@@ -363,6 +579,14 @@ static void process_file_enhanced(const char *input_file, const char *output_fil
         return;
     }
 
+    RecordBatch batch;
+    if (!batch_init(&batch, RECORD_BATCH_SIZE, ARENA_SIZE)) {
+        fprintf(stderr, "Error allocating record batch: %s\n", strerror(errno));
+        fclose(csv);
+        fclose(out);
+        return;
+    }
+
     // Auto-detect encoding and delimiter if needed
     if (config->encoding == ENCODING_AUTO) {
         config->encoding = detect_encoding(csv);
@@ -372,13 +596,11 @@ static void process_file_enhanced(const char *input_file, const char *output_fil
     }
 
     char line[MAX_LINE_LENGTH];
-    char fields[MAX_FIELDS][MAX_LINE_LENGTH];
-    const char *field_ptrs[MAX_FIELDS];
     unsigned int *seen_hashes = NULL;
     int hash_count = 0;
+    int alloc_size = config->max_lines > 0 ? config->max_lines : 100000; // Default allocation for unlimited mode
 
     if (config->remove_duplicates) {
-        int alloc_size = config->max_lines > 0 ? config->max_lines : 100000; // Default allocation for unlimited mode
         seen_hashes = calloc(alloc_size, sizeof(unsigned int));
     }
 
@@ -393,67 +615,24 @@ static void process_file_enhanced(const char *input_file, const char *output_fil
         printf("Header: %s", line);
     }
 
-    // Process data lines
-    while (fgets(line, sizeof(line), csv) && 
-           (config->max_lines == 0 || stats->processed_lines < config->max_lines)) {
-        stats->total_lines++;
-
-        // Remove newline
-        line[strcspn(line, "\r\n")] = '\0';
-        if (strlen(line) == 0) continue;
-
-        int field_count = parse_csv_line(line, fields, MAX_FIELDS, config->delimiter);
-
-        // Validate minimum field count
-        bool valid = true;
-        if (field_count < config->field_count) {
-            stats->error_lines++;
-            if (config->strict_mode) continue;
-            valid = false;
-        }
-
-        // Clean and validate fields
-        for (int i = 0; i < field_count && i < config->field_count; i++) {
-            clean_text(fields[i], MAX_LINE_LENGTH, config->strict_mode);
-            field_ptrs[i] = fields[i];
-
-            if (config->validate_data && !validate_field(fields[i], &config->fields[i])) {
-                valid = false;
-                break;
-            }
+    // Process data lines a batch at a time. A batch never holds more rows than
+    // the remaining line budget, so no input is read past max_lines.
+    while (config->max_lines == 0 || stats->processed_lines < config->max_lines) {
+        int limit = RECORD_BATCH_SIZE;
+        if (config->max_lines > 0 && config->max_lines - stats->processed_lines < limit) {
+            limit = config->max_lines - stats->processed_lines;
         }
 
-        if (!valid) {
-            stats->error_lines++;
-            if (config->strict_mode) continue;
-        }
-
-        // Check for duplicates
-        if (config->remove_duplicates && field_count > 0) {
-            int alloc_size = config->max_lines > 0 ? config->max_lines : 100000;
-            if (is_duplicate(fields[0], seen_hashes, &hash_count, alloc_size)) {
-                stats->duplicate_lines++;
-                continue;
-            }
-        }
+        if (fill_batch(csv, &batch, limit, config->delimiter, stats) == 0) break;
 
-        // Write output in specified format
-        if (strcmp(config->output_format, "json") == 0) {
-            write_output_json(out, field_ptrs, config->fields, field_count);
-        } else {
-            write_output_txt(out, field_ptrs, config->fields, field_count, config->type);
-        }
-
-        stats->processed_lines++;
-        stats->avg_text_length += strlen(fields[0]);
-
-        if (stats->processed_lines % 1000 == 0) {
-            printf("Processed %d/%d lines (%.1f%%)...\n", 
-                   stats->processed_lines, stats->total_lines,
-                   100.0 * stats->processed_lines / stats->total_lines);
+        clean_batch(&batch, config, stats);
+        if (seen_hashes) {
+            dedup_batch(&batch, seen_hashes, &hash_count, alloc_size, stats);
         }
+        write_batch(out, &batch, config, stats);
     }
 
+    batch_free(&batch);
     if (seen_hashes) free(seen_hashes);
     fclose(csv);
     fclose(out);